@@ -4,7 +4,9 @@
 #include "SFML/Graphics/VertexBuffer.hpp"
 #include "SFML/Window/Event.hpp"
 #include <cellaut-cpp/CellularAutomata.h>
+#include <cellaut-cpp/History.h>
 #include "Controls.h"
+#include <optional>
 #include <random>
 
 struct Air;
@@ -195,6 +197,7 @@ int main() {
     Controls controls;
     WorldType blockSelected = WorldType::Sand;
     bool addBlocks = false;
+    bool zoomedOut = false;
 
     controls.RegisterEvent(sf::Event::EventType::Closed, [&sfmlWin](const sf::Event&) { sfmlWin.close(); });
     controls.RegisterEvent(sf::Event::EventType::MouseButtonPressed, [&](const sf::Event& e) {
@@ -223,8 +226,21 @@ int main() {
         if (e.key.code == sf::Keyboard::Num5) {
             blockSelected = WorldType::Stone;
         }
+        if (e.key.code == sf::Keyboard::Z) {
+            zoomedOut = !zoomedOut;
+            if (zoomedOut) {
+                automata.EnableSummary();
+            }
+            else {
+                automata.DisableSummary();
+            }
+        }
     });
     buildWorld(automata);
+    std::optional<HistoryRecorder> recorder;
+    if (false /* Record the run to a file */) {
+        recorder.emplace("history.cahr", automata);
+    }
     while (sfmlWin.isOpen()) {
         controls.HandleEvents(sfmlWin);
 
@@ -272,41 +288,95 @@ int main() {
             std::cout << "Step time: " << duration.count() << " ms\n";
         }
 
+        if (recorder) {
+            auto start = std::chrono::high_resolution_clock::now();
+            recorder->Record(automata);
+            auto end = std::chrono::high_resolution_clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+            std::cout << "Record time: " << duration.count() << " ms\n";
+        }
+
         {
             auto start = std::chrono::high_resolution_clock::now();
             sfmlWin.clear(sf::Color(173, 216, 230));
             std::vector<sf::Vertex> cells;
-            for (ShortInt y = 0; y < automata.GetHeight(); y++) {
-                for (ShortInt x = 0; x < automata.GetWidth(); x++) {
-                    Cell cell = {x, y};
-                    if (automata.template IsAt<Air>(cell)) {
-                        continue;
+            if (zoomedOut) {
+                // Draw the most common state of every block, the cost follows the
+                // number of blocks rather than the number of cells.
+                const auto& summary = automata.GetSummary();
+                const size_t level = summary.GetLevelFor(width / 8, height / 8);
+                const auto blockSize = static_cast<float>(summary.GetBlockSize(level));
+                std::vector<size_t> tags;
+                summary.GetDominant(level, tags);
+                for (size_t by = 0; by < summary.GetHeight(level); by++) {
+                    for (size_t bx = 0; bx < summary.GetWidth(level); bx++) {
+                        const size_t tag = tags[bx + by * summary.GetWidth(level)];
+                        sf::Color color;
+                        if (tag == CellularAutomataT::TagOf<Air>()) {
+                            continue;
+                        }
+                        else if (tag == CellularAutomataT::TagOf<Sand>()) {
+                            color = sf::Color::Yellow;
+                        }
+                        else if (tag == CellularAutomataT::TagOf<Dirt>()) {
+                            color = sf::Color(139, 69, 19);
+                        }
+                        else if (tag == CellularAutomataT::TagOf<Grass>()) {
+                            color = sf::Color::Green;
+                        }
+                        else if (tag == CellularAutomataT::TagOf<Water>()) {
+                            color = sf::Color::Blue;
+                        }
+                        else if (tag == CellularAutomataT::TagOf<Stone>()) {
+                            color = sf::Color(128, 128, 128);
+                        }
+                        else if (tag == CellularAutomataT::TagOf<Fire>()) {
+                            color = sf::Color::Red;
+                        }
+                        const sf::Vector2f topLeft(bx * blockSize, by * blockSize);
+                        cells.emplace_back(topLeft, color);
+                        cells.emplace_back(topLeft + sf::Vector2f(blockSize, 0), color);
+                        cells.emplace_back(topLeft + sf::Vector2f(blockSize, blockSize), color);
+                        cells.emplace_back(topLeft + sf::Vector2f(0, blockSize), color);
                     }
-                    sf::Color color;
-                    if (automata.template IsAt<Sand>(cell)) {
-                        color = sf::Color::Yellow;
-                    }
-                    else if (automata.template IsAt<Dirt>(cell)) {
-                        static const sf::Color brown = sf::Color(139, 69, 19);
-                        color = brown;
-                    }
-                    else if (automata.template IsAt<Grass>(cell)) {
-                        color = sf::Color::Green;
-                    }
-                    else if (automata.template IsAt<Water>(cell)) {
-                        color = sf::Color::Blue;
-                    }
-                    else if (automata.template IsAt<Stone>(cell)) {
-                        static const sf::Color gray = sf::Color(128, 128, 128);
-                        color = gray;
-                    }
-                    else if (automata.template IsAt<Fire>(cell)) {
-                        color = sf::Color::Red;
+                }
+                if (!cells.empty()) {
+                    sfmlWin.draw(&cells[0], cells.size(), sf::Quads);
+                }
+            }
+            else {
+                for (ShortInt y = 0; y < automata.GetHeight(); y++) {
+                    for (ShortInt x = 0; x < automata.GetWidth(); x++) {
+                        Cell cell = {x, y};
+                        if (automata.template IsAt<Air>(cell)) {
+                            continue;
+                        }
+                        sf::Color color;
+                        if (automata.template IsAt<Sand>(cell)) {
+                            color = sf::Color::Yellow;
+                        }
+                        else if (automata.template IsAt<Dirt>(cell)) {
+                            static const sf::Color brown = sf::Color(139, 69, 19);
+                            color = brown;
+                        }
+                        else if (automata.template IsAt<Grass>(cell)) {
+                            color = sf::Color::Green;
+                        }
+                        else if (automata.template IsAt<Water>(cell)) {
+                            color = sf::Color::Blue;
+                        }
+                        else if (automata.template IsAt<Stone>(cell)) {
+                            static const sf::Color gray = sf::Color(128, 128, 128);
+                            color = gray;
+                        }
+                        else if (automata.template IsAt<Fire>(cell)) {
+                            color = sf::Color::Red;
+                        }
+                        cells.emplace_back(sf::Vector2f(x, y), color);
                     }
-                    cells.emplace_back(sf::Vector2f(x, y), color);
                 }
+                sfmlWin.draw(&cells[0], cells.size(), sf::Points);
             }
-            sfmlWin.draw(&cells[0], cells.size(), sf::Points);
             sfmlWin.display();
             auto end = std::chrono::high_resolution_clock::now();
             auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
@@ -45,12 +45,14 @@ void ProcessBinary(auto& neighborhood, bool centralVal) {
 }
 
 struct Zero {
+    static constexpr bool IsLocal = true;
     void Process(auto& neighborhood) {
         ProcessBinary(neighborhood, false);
     }
 };
 
 struct One {
+    static constexpr bool IsLocal = true;
     void Process(auto& neighborhood) {
         ProcessBinary(neighborhood, true);
     }
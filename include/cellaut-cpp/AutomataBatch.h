@@ -0,0 +1,158 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "CellularAutomata.h"
+
+/**
+ * @brief Many automata of the same states and size stepped together.
+ * Every Step hands the worlds out one world per task to a pool of threads
+ * that lives as long as the batch, so stepping thousands of small worlds
+ * does not pay for thread start-up on every step. Each world is a regular
+ * CellularAutomata that owns its own grids, the batch only adds the threads.
+ */
+template<typename... TStates>
+class AutomataBatch {
+public:
+    using TAutomata = CellularAutomata<TStates...>;
+
+    /**
+     * @brief Creates the worlds and starts the threads
+     * @param count Number of worlds
+     * @param width Width of every world
+     * @param height Height of every world
+     * @param threadCount Number of threads stepping, including the calling thread
+     */
+    AutomataBatch(size_t count, ShortInt width, ShortInt height,
+                  size_t threadCount = std::thread::hardware_concurrency()) {
+        worlds.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            worlds.emplace_back(width, height);
+        }
+        try {
+            for (size_t i = 1; i < std::min(std::max<size_t>(threadCount, 1), count); i++) {
+                workers.emplace_back([this] { WorkerLoop(); });
+            }
+        }
+        catch (...) {
+            StopWorkers();
+            throw;
+        }
+    }
+
+    AutomataBatch(const AutomataBatch&) = delete;
+    AutomataBatch& operator=(const AutomataBatch&) = delete;
+    AutomataBatch(AutomataBatch&&) = delete;
+    AutomataBatch& operator=(AutomataBatch&&) = delete;
+
+    ~AutomataBatch() {
+        StopWorkers();
+    }
+
+    /**
+     * @brief Returns the number of worlds in the batch
+     */
+    [[nodiscard]] size_t Size() const {
+        return worlds.size();
+    }
+
+    /**
+     * @brief Returns a world of the batch, it must not be used from
+     * another thread while the batch is stepping
+     * @param index The index of the world
+     * @return The world
+     */
+    [[nodiscard]] TAutomata& operator[](size_t index) {
+        return worlds[index];
+    }
+
+    [[nodiscard]] const TAutomata& operator[](size_t index) const {
+        return worlds[index];
+    }
+
+    [[nodiscard]] auto begin() {
+        return worlds.begin();
+    }
+
+    [[nodiscard]] auto end() {
+        return worlds.end();
+    }
+
+    /**
+     * @brief Steps every world, a task steps one world all the generations
+     * so the threads only synchronise once per call
+     * @param generations Number of steps to take
+     */
+    void Step(size_t generations = 1) {
+        pendingGenerations = generations;
+        nextWorld = 0;
+        if (workers.empty()) {
+            StepWorlds();
+            return;
+        }
+        {
+            std::lock_guard lock(mutex);
+            busyWorkers = workers.size();
+            round++;
+        }
+        wake.notify_all();
+        StepWorlds();
+        std::unique_lock lock(mutex);
+        done.wait(lock, [this] { return busyWorkers == 0; });
+    }
+
+private:
+    void StopWorkers() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void StepWorlds() {
+        for (size_t i = nextWorld.fetch_add(1); i < worlds.size(); i = nextWorld.fetch_add(1)) {
+            for (size_t generation = 0; generation < pendingGenerations; generation++) {
+                worlds[i].Step();
+            }
+        }
+    }
+
+    void WorkerLoop() {
+        size_t seenRound = 0;
+        while (true) {
+            {
+                std::unique_lock lock(mutex);
+                wake.wait(lock, [&] { return stopping || round != seenRound; });
+                if (stopping) {
+                    return;
+                }
+                seenRound = round;
+            }
+            StepWorlds();
+            {
+                std::lock_guard lock(mutex);
+                busyWorkers--;
+            }
+            done.notify_one();
+        }
+    }
+
+    std::vector<TAutomata> worlds;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    size_t round = 0;
+    size_t busyWorkers = 0;
+    bool stopping = false;
+    size_t pendingGenerations = 1;
+    std::atomic<size_t> nextWorld = 0;
+};
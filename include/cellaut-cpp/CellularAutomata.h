@@ -1,8 +1,18 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <variant>
 #include <set>
+#include <stdexcept>
 #include <vector>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <utility>
 #include <type_traits>
+#include "SummaryPyramid.h"
 
 using ShortInt = unsigned short int;
 
@@ -52,10 +62,23 @@ concept State = requires(TState state, TNeighborhood neighborhood) {
     { state.Process(neighborhood) };
 };
 
+/**
+ * @brief Concept for states whose Process only looks at the 3x3 neighborhood
+ * of the center cell, only sets the center cell and does so deterministically.
+ * States opt in with `static constexpr bool IsLocal = true;`, when all states
+ * of an automata are local it can step fully active grids densely.
+ * @tparam TState The state to check
+ */
+template <typename TState>
+concept LocalState = requires {
+    requires TState::IsLocal;
+};
+
 template<typename... TStates>
 class CellularAutomata {
 private:
     using TAutomata = CellularAutomata<TStates...>;
+    using Variant = std::variant<TStates...>;
 
     /**
      * @brief Represents the neighborhood of a cell, this is used to
@@ -143,6 +166,201 @@ private:
         const Cell& centerCell;
     };
 
+    /**
+     * @brief Neighborhood used by Step, the state of the center cell is known
+     * at compile time so no type dispatch is needed, and the automata is read
+     * without the bounds checked accessors.
+     * Exposes the same API as Neighborhood.
+     * @tparam TCenter The state of the center cell
+     */
+    template<typename TCenter>
+    class StateNeighborhood {
+    public:
+        StateNeighborhood(const Cell& cell, TAutomata& automata) : centerCell(cell), automata(automata) {}
+        StateNeighborhood(const StateNeighborhood&) = delete;
+        StateNeighborhood& operator=(const StateNeighborhood&) = delete;
+        StateNeighborhood(StateNeighborhood&&) = delete;
+        StateNeighborhood& operator=(StateNeighborhood&&) = delete;
+
+        /**
+         * @brief Returns the center cell of the neighborhood
+         * @return The center cell
+         */
+        [[nodiscard]]
+        const Cell& GetCenter() const {
+            return centerCell;
+        }
+
+        /**
+         * @brief Sets the state of the center cell
+         * @tparam TState The state to set
+         */
+        template<State<Neighborhood> TState>
+        void Set() {
+            automata.template SetUnchecked<TState>(centerCell);
+        }
+
+        /**
+         * @brief Returns the state of the cell, read from the states
+         * committed by the last step
+         * @tparam TState The state to check
+         * @param cell The cell to check
+         * @return True if the cell is valid and of the state, false otherwise
+         */
+        template<State<Neighborhood> TState>
+        [[nodiscard]] bool IsAt(const Cell& cell) const {
+            constexpr size_t tag = TagOf<TState>();
+            return automata.IsValid(cell) && automata.states[automata.GetIndex(cell)].index() == tag;
+        }
+
+        /**
+         * @brief Checks if the cell is valid
+         * @param cell The cell to check
+         * @return True if the cell is valid, false otherwise
+         */
+        [[nodiscard]] bool IsValid(const Cell& cell) const {
+            return automata.IsValid(cell);
+        }
+
+        /**
+         * @brief Swaps the state of the center cell with the target cell
+         * if the target cell is of the target state, both states are known
+         * statically so the swap is two plain sets.
+         * @tparam TTargetState The target state
+         * @param target The target cell
+         * @return True if the swap was successful, false otherwise
+         */
+        template <State<Neighborhood> TTargetState>
+        [[nodiscard]] bool SwapIfTargetIs(const Cell& target) {
+            if (!IsAt<TTargetState>(target)) {
+                return false;
+            }
+            automata.template SetUnchecked<TCenter>(target);
+            automata.template SetUnchecked<TTargetState>(centerCell);
+            return true;
+        }
+
+        /**
+         * @brief Returns the width of the automata
+         * @return The width of the automata
+         */
+        [[nodiscard]]
+        ShortInt GetWidth() const {
+            return automata.GetWidth();
+        }
+
+        /**
+         * @brief Returns the height of the automata
+         * @return The height of the automata
+         */
+        [[nodiscard]]
+        ShortInt GetHeight() const {
+            return automata.GetHeight();
+        }
+
+    private:
+        const Cell& centerCell;
+        TAutomata& automata;
+    };
+
+    /**
+     * @brief A tile of the grid copied out for dense stepping, with a halo
+     * around it that is as deep as the number of generations computed.
+     */
+    struct DenseTile {
+        ShortInt left = 0;
+        ShortInt top = 0;
+        ShortInt width = 0;
+        ShortInt height = 0;
+        std::vector<uint8_t> current;
+        std::vector<uint8_t> next;
+
+        [[nodiscard]] size_t GetIndex(const Cell& cell) const {
+            return (cell.x - left) + static_cast<size_t>(cell.y - top) * width;
+        }
+    };
+
+    /**
+     * @brief Neighborhood used by dense stepping, reads the previous generation
+     * of the tile and writes the center cell of the next one. Only exposes what
+     * a LocalState may use.
+     * @tparam TCenter The state of the center cell
+     */
+    template<typename TCenter>
+    class LocalNeighborhood {
+    public:
+        LocalNeighborhood(const Cell& cell, const TAutomata& automata, const DenseTile& tile, uint8_t& center)
+            : centerCell(cell), automata(automata), tile(tile), center(center) {}
+        LocalNeighborhood(const LocalNeighborhood&) = delete;
+        LocalNeighborhood& operator=(const LocalNeighborhood&) = delete;
+        LocalNeighborhood(LocalNeighborhood&&) = delete;
+        LocalNeighborhood& operator=(LocalNeighborhood&&) = delete;
+
+        /**
+         * @brief Returns the center cell of the neighborhood
+         * @return The center cell
+         */
+        [[nodiscard]]
+        const Cell& GetCenter() const {
+            return centerCell;
+        }
+
+        /**
+         * @brief Sets the state of the center cell in the next generation of the tile
+         * @tparam TState The state to set
+         */
+        template<State<Neighborhood> TState>
+        void Set() {
+            constexpr auto tag = static_cast<uint8_t>(TagOf<TState>());
+            center = tag;
+        }
+
+        /**
+         * @brief Returns the state of the cell in the previous generation of the tile
+         * @tparam TState The state to check
+         * @param cell The cell to check, must be within one cell of the center
+         * @return True if the cell is valid and of the state, false otherwise
+         */
+        template<State<Neighborhood> TState>
+        [[nodiscard]] bool IsAt(const Cell& cell) const {
+            constexpr size_t tag = TagOf<TState>();
+            return automata.IsValid(cell) && tile.current[tile.GetIndex(cell)] == tag;
+        }
+
+        /**
+         * @brief Checks if the cell is valid
+         * @param cell The cell to check
+         * @return True if the cell is valid, false otherwise
+         */
+        [[nodiscard]] bool IsValid(const Cell& cell) const {
+            return automata.IsValid(cell);
+        }
+
+        /**
+         * @brief Returns the width of the automata
+         * @return The width of the automata
+         */
+        [[nodiscard]]
+        ShortInt GetWidth() const {
+            return automata.GetWidth();
+        }
+
+        /**
+         * @brief Returns the height of the automata
+         * @return The height of the automata
+         */
+        [[nodiscard]]
+        ShortInt GetHeight() const {
+            return automata.GetHeight();
+        }
+
+    private:
+        const Cell& centerCell;
+        const TAutomata& automata;
+        const DenseTile& tile;
+        uint8_t& center;
+    };
+
 public:
     constexpr CellularAutomata(const ShortInt Width, const ShortInt Height) : Width(Width), Height(Height) {
         updatedStates.resize(Width * Height);
@@ -180,19 +398,96 @@ public:
         return Height;
     }
 
+    /**
+     * @brief True when every state is a LocalState, which allows dense stepping
+     */
+    static constexpr bool SupportsDenseStepping = (LocalState<TStates> && ...);
+
     /**
      * @brief Steps the automata one step
      */
     void Step() {
-        for (const auto& cell : GetPassiveBuffer()) {
-            std::visit([&](auto&& state){
-                Neighborhood neighborhood(cell, *this);
-                state.Process(neighborhood);
-            }, states.at(GetIndex(cell)));
+        StepSparse();
+    }
+
+    /**
+     * @brief Steps the automata several steps. While the grid is densely
+     * active and every state is local, up to maxTemporalDepth generations
+     * are computed per tile before moving on and committed together, so
+     * GetCommittedCells and the summary cover all of them. While statistics
+     * or transition callbacks are enabled every generation is committed on
+     * its own instead, so no transition is missed. Cells set since the last
+     * step are committed by a sparse first generation, as Step would.
+     * @param generations The number of steps to take
+     */
+    void Advance(size_t generations) {
+        while (generations > 0) {
+            if constexpr (SupportsDenseStepping) {
+                // Dense stepping reads only the committed states, pending sets
+                // would be lost or land generations late.
+                if (IsDenselyActive() && GetActiveBuffer().empty()) {
+                    const size_t depth = IsObserved() ? 1 : std::min(generations, maxTemporalDepth);
+                    StepDense(depth);
+                    generations -= depth;
+                    continue;
+                }
+            }
+            StepSparse();
+            generations--;
+        }
+    }
+
+    /**
+     * @brief Sets the fraction of the grid that has to be active for
+     * Advance to step densely instead of using the sparse frontier
+     * @param threshold The fraction, 0 always steps densely and values above 1 never do
+     */
+    void SetDenseThreshold(double threshold) {
+        denseThreshold = threshold;
+    }
+
+    /**
+     * @brief Steps the automata one step by processing every cell of the grid
+     * in order through the generic, bounds checked neighborhood. This is slow
+     * and meant as the reference the optimised stepping is checked against.
+     */
+    void StepReference() {
+        for (ShortInt y = 0; y < Height; y++) {
+            for (ShortInt x = 0; x < Width; x++) {
+                const Cell cell = {x, y};
+                std::visit([&](auto&& state){
+                    Neighborhood neighborhood(cell, *this);
+                    state.Process(neighborhood);
+                }, states.at(GetIndex(cell)));
+            }
         }
         Commit();
     }
 
+    /**
+     * @brief Checks if every cell of the other automata is in the same state,
+     * states are compared by tag only
+     * @param other The automata to compare with
+     * @return True if the automata have the same size and states, false otherwise
+     */
+    [[nodiscard]] bool HasSameStates(const CellularAutomata& other) const {
+        return Width == other.Width && Height == other.Height &&
+            std::equal(states.begin(), states.end(), other.states.begin(), [](const auto& a, const auto& b) {
+                return a.index() == b.index();
+            });
+    }
+
+    /**
+     * @brief Returns how many cells of the state were processed by the last step,
+     * only counted when the step used the sparse frontier
+     * @tparam TState The state to check
+     * @return The number of cells of the state processed
+     */
+    template<State<Neighborhood> TState>
+    [[nodiscard]] size_t GetProcessedCount() const {
+        return processedCounts[TagOf<TState>()];
+    }
+
     /**
      * @brief Checks if the cell is of the state
      * @tparam TState The state to check
@@ -212,24 +507,7 @@ public:
     template<State<Neighborhood> TState>
     void Set(const Cell& cell) {
         updatedStates.at(GetIndex(cell)) = TState{};
-
-        auto& buffer = GetActiveBuffer();
-        buffer.push_back(cell);
-        for (int x = -neighborhoodSize; x <= neighborhoodSize; x++) {
-            for (int y = -neighborhoodSize; y <= neighborhoodSize; y++) {
-                if (x == 0 && y == 0) {
-                    continue;
-                }
-                Cell newCell = {static_cast<ShortInt>(cell.x + x), static_cast<ShortInt>(cell.y + y)};
-                if (!IsValid(newCell)) {
-                    continue;
-                }
-                if (!changedCells.at(GetIndex(newCell))) {
-                    buffer.push_back(newCell);
-                    changedCells.at(GetIndex(newCell)) = true;
-                }
-            }
-        }
+        Enqueue(cell);
     }
 
     /**
@@ -259,6 +537,192 @@ public:
         return states.size();
     }
 
+    /**
+     * @brief Number of states the automata was declared with
+     */
+    static constexpr size_t StateCount = sizeof...(TStates);
+
+    /**
+     * @brief Returns the tag of a state, i.e. its position in the
+     * state list of the automata
+     * @tparam TState The state to get the tag of
+     * @return The tag of the state
+     */
+    template<State<Neighborhood> TState>
+    [[nodiscard]] static constexpr size_t TagOf() {
+        constexpr std::array<bool, StateCount> matches = {std::is_same_v<TState, TStates>...};
+        for (size_t tag = 0; tag < StateCount; tag++) {
+            if (matches[tag]) {
+                return tag;
+            }
+        }
+        return StateCount;
+    }
+
+    /**
+     * @brief Returns the tag of the state the cell is in
+     * @param cell The cell to check
+     * @return The tag of the state of the cell
+     */
+    [[nodiscard]] size_t GetTag(const Cell& cell) const {
+        return states.at(GetIndex(cell)).index();
+    }
+
+    /**
+     * @brief Sets the state of the cell from a tag, the runtime
+     * counterpart of Set
+     * @param cell The cell to set the state of
+     * @param tag The tag of the state to set
+     */
+    void SetTag(const Cell& cell, size_t tag) {
+        SetTag(cell, tag, std::index_sequence_for<TStates...>{});
+    }
+
+    /**
+     * @brief Replaces the state of every cell from a list of tags and commits
+     * it like a step, so the summary, statistics and transition callbacks see
+     * the cells that changed. Sets made since the last step are dropped, and
+     * every cell is processed by the next step.
+     * @param tags The tag of every cell in row-major order
+     */
+    template<typename TTags>
+    void Load(const TTags& tags) {
+        if (tags.size() != Size()) {
+            throw std::invalid_argument("CellularAutomata: Load needs one tag per cell");
+        }
+        if (std::any_of(tags.begin(), tags.end(), [](auto tag) { return static_cast<size_t>(tag) >= StateCount; })) {
+            throw std::invalid_argument("CellularAutomata: Load got a tag without a state");
+        }
+        for (const auto& cell : GetActiveBuffer()) {
+            updatedStates[GetIndex(cell)] = states[GetIndex(cell)];
+            changedCells[GetIndex(cell)] = false;
+        }
+        GetActiveBuffer().clear();
+
+        processedCounts.fill(0);
+        for (size_t index = 0; index < Size(); index++) {
+            const auto tag = static_cast<size_t>(tags[index]);
+            if (states[index].index() != tag) {
+                updatedStates[index] = MakeState(tag, std::index_sequence_for<TStates...>{});
+            }
+        }
+        // The frontier that led to the current states says nothing about the
+        // loaded ones, so every cell is processed by the next step.
+        EnqueueAll();
+        Commit();
+    }
+
+    /**
+     * @brief Starts maintaining a summary pyramid of per-block state
+     * histograms, for reading downsampled views of the automata.
+     * Building it scans the grid once, afterwards it is kept up to date
+     * from the cells that change on every step.
+     */
+    void EnableSummary() {
+        summary.emplace(Width, Height, StateCount);
+        for (ShortInt y = 0; y < Height; y++) {
+            for (ShortInt x = 0; x < Width; x++) {
+                summary->Add(x, y, states[GetIndex({x, y})].index());
+            }
+        }
+    }
+
+    /**
+     * @brief Stops maintaining the summary pyramid and frees it
+     */
+    void DisableSummary() {
+        summary.reset();
+    }
+
+    /**
+     * @brief Returns the summary pyramid, EnableSummary must have been called
+     * @return The summary pyramid
+     */
+    [[nodiscard]] const SummaryPyramid& GetSummary() const {
+        return summary.value();
+    }
+
+    /**
+     * @brief Starts counting the population of every state and the
+     * transitions between states committed by each step. Counting the
+     * populations scans the grid once, afterwards both are kept up to
+     * date from the cells that change on every step.
+     */
+    void EnableStatistics() {
+        statistics.emplace();
+        for (const auto& state : states) {
+            statistics->populations[state.index()]++;
+        }
+    }
+
+    /**
+     * @brief Stops counting populations and transitions
+     */
+    void DisableStatistics() {
+        statistics.reset();
+    }
+
+    /**
+     * @brief Returns how many cells are of the state, EnableStatistics
+     * must have been called
+     * @tparam TState The state to count
+     * @return The number of cells of the state
+     */
+    template<State<Neighborhood> TState>
+    [[nodiscard]] size_t GetPopulation() const {
+        return statistics.value().populations[TagOf<TState>()];
+    }
+
+    /**
+     * @brief Returns how many cells went from one state to another in the
+     * last step, EnableStatistics must have been called. Advance commits every
+     * generation on its own while statistics are enabled, so after it this
+     * covers its last generation.
+     * @tparam TFromState The state the cells were in
+     * @tparam TToState The state the cells are in now
+     * @return The number of cells that changed from TFromState to TToState
+     */
+    template<State<Neighborhood> TFromState, State<Neighborhood> TToState>
+    [[nodiscard]] size_t GetTransitionCount() const {
+        return statistics.value().transitions[TagOf<TFromState>() * StateCount + TagOf<TToState>()];
+    }
+
+    using TransitionCallback = std::function<void(const Cell&)>;
+
+    /**
+     * @brief Registers a callback called for every cell that goes from one
+     * state to another when a step is committed. The callback runs in the
+     * middle of the commit and must not modify the automata.
+     * @tparam TFromState The state the cell was in
+     * @tparam TToState The state the cell is in now
+     * @param callback The callback, called with the cell that changed
+     */
+    template<State<Neighborhood> TFromState, State<Neighborhood> TToState>
+    void OnTransition(TransitionCallback callback) {
+        transitionCallbacks[TagOf<TFromState>() * StateCount + TagOf<TToState>()].push_back(std::move(callback));
+        transitionCallbackCount++;
+    }
+
+    /**
+     * @brief Removes all transition callbacks
+     */
+    void ClearTransitionCallbacks() {
+        for (auto& callbacks : transitionCallbacks) {
+            callbacks.clear();
+        }
+        transitionCallbackCount = 0;
+    }
+
+    /**
+     * @brief Returns the cells that were committed by the last step,
+     * every cell whose state changed is in here once, but the buffer
+     * may also contain unchanged cells.
+     * @return The cells committed by the last step
+     */
+    [[nodiscard]] const std::vector<Cell>& GetCommittedCells() const {
+        return firstBufferActive ? previouslyModifiedCells : modifiedCells;
+    }
+
     /**
      * Checks if the cell is valid.
      * @param cell The cell to check
@@ -270,14 +734,211 @@ public:
 
 private:
     void Commit() {
-        for (const auto& cell : GetActiveBuffer()) {
-            states.at(GetIndex(cell)) = updatedStates.at(GetIndex(cell));
-            changedCells.at(GetIndex(cell)) = false;
+        if (summary || statistics || transitionCallbackCount > 0) {
+            if (statistics) {
+                statistics->transitions.fill(0);
+            }
+            for (const auto& cell : GetActiveBuffer()) {
+                const size_t fromTag = states.at(GetIndex(cell)).index();
+                const size_t toTag = updatedStates.at(GetIndex(cell)).index();
+                if (fromTag != toTag) {
+                    ApplyTransition(cell, fromTag, toTag);
+                }
+                states.at(GetIndex(cell)) = updatedStates.at(GetIndex(cell));
+                changedCells.at(GetIndex(cell)) = false;
+            }
+        }
+        else {
+            for (const auto& cell : GetActiveBuffer()) {
+                states.at(GetIndex(cell)) = updatedStates.at(GetIndex(cell));
+                changedCells.at(GetIndex(cell)) = false;
+            }
         }
         firstBufferActive = !firstBufferActive;
         GetActiveBuffer().clear();
     }
 
+    void StepSparse() {
+        processedCounts.fill(0);
+        const auto& buffer = GetPassiveBuffer();
+        for (const auto& cell : buffer) {
+            ProcessCell(cell, std::index_sequence_for<TStates...>{});
+        }
+        Commit();
+    }
+
+    [[nodiscard]] bool IsObserved() const {
+        return statistics || transitionCallbackCount > 0;
+    }
+
+    [[nodiscard]] bool IsDenselyActive() {
+        return static_cast<double>(GetPassiveBuffer().size()) >= denseThreshold * static_cast<double>(Size());
+    }
+
+    /**
+     * @brief Computes depth generations of every cell tile by tile. Each tile
+     * is loaded with a halo of depth cells, every generation is computed on a
+     * region one cell smaller than the last so the tile interior is exact after
+     * the last one, and the grid is only streamed through once for all of them.
+     * The cells that changed are then set and committed as a regular step.
+     */
+    void StepDense(size_t depth) {
+        static_assert(StateCount <= 256, "Dense stepping stores tags in a single byte");
+        processedCounts.fill(0);
+        denseChanges.clear();
+        for (size_t top = 0; top < Height; top += denseTileSize) {
+            for (size_t left = 0; left < Width; left += denseTileSize) {
+                const size_t right = std::min<size_t>(left + denseTileSize, Width);
+                const size_t bottom = std::min<size_t>(top + denseTileSize, Height);
+                StepDenseTile(left, top, right, bottom, depth);
+            }
+        }
+
+        // While most of the grid keeps changing, queueing every cell in order is
+        // cheaper than building the exact frontier around each changed cell.
+        if (static_cast<double>(denseChanges.size()) >= denseThreshold * static_cast<double>(Size())) {
+            EnqueueAll();
+        }
+        else {
+            for (const auto& cell : denseChanges) {
+                Enqueue(cell);
+            }
+        }
+        Commit();
+    }
+
+    void StepDenseTile(size_t left, size_t top, size_t right, size_t bottom, size_t depth) {
+        auto& tile = denseTile;
+        tile.left = static_cast<ShortInt>(left - std::min(left, depth));
+        tile.top = static_cast<ShortInt>(top - std::min(top, depth));
+        tile.width = static_cast<ShortInt>(std::min<size_t>(right + depth, Width) - tile.left);
+        tile.height = static_cast<ShortInt>(std::min<size_t>(bottom + depth, Height) - tile.top);
+        tile.current.resize(static_cast<size_t>(tile.width) * tile.height);
+        for (ShortInt y = 0; y < tile.height; y++) {
+            for (ShortInt x = 0; x < tile.width; x++) {
+                tile.current[x + static_cast<size_t>(y) * tile.width] =
+                    static_cast<uint8_t>(states[GetIndex({static_cast<ShortInt>(tile.left + x), static_cast<ShortInt>(tile.top + y)})].index());
+            }
+        }
+        tile.next = tile.current;
+
+        for (size_t generation = 1; generation <= depth; generation++) {
+            const size_t margin = depth - generation;
+            const auto regionLeft = static_cast<ShortInt>(std::max<size_t>(left - std::min(left, margin), tile.left));
+            const auto regionTop = static_cast<ShortInt>(std::max<size_t>(top - std::min(top, margin), tile.top));
+            const auto regionRight = static_cast<ShortInt>(std::min<size_t>(right + margin, tile.left + tile.width));
+            const auto regionBottom = static_cast<ShortInt>(std::min<size_t>(bottom + margin, tile.top + tile.height));
+            for (ShortInt y = regionTop; y < regionBottom; y++) {
+                for (ShortInt x = regionLeft; x < regionRight; x++) {
+                    const Cell cell = {x, y};
+                    const size_t index = tile.GetIndex(cell);
+                    tile.next[index] = tile.current[index];
+                    ProcessLocal(cell, tile.current[index], tile.next[index], std::index_sequence_for<TStates...>{});
+                }
+            }
+            std::swap(tile.current, tile.next);
+        }
+
+        for (auto y = static_cast<ShortInt>(top); y < bottom; y++) {
+            for (auto x = static_cast<ShortInt>(left); x < right; x++) {
+                const Cell cell = {x, y};
+                const size_t tag = tile.current[tile.GetIndex(cell)];
+                if (states[GetIndex(cell)].index() != tag) {
+                    updatedStates[GetIndex(cell)] = MakeState(tag, std::index_sequence_for<TStates...>{});
+                    denseChanges.push_back(cell);
+                }
+            }
+        }
+    }
+
+    template<size_t... Is>
+    static Variant MakeState(size_t tag, std::index_sequence<Is...>) {
+        Variant state;
+        ((tag == Is ? (state.template emplace<Is>(), true) : false) || ...);
+        return state;
+    }
+
+    template<size_t... Is>
+    void ProcessLocal(const Cell& cell, size_t tag, uint8_t& center, std::index_sequence<Is...>) {
+        ((tag == Is ? (ProcessLocal<Is>(cell, center), true) : false) || ...);
+    }
+
+    template<size_t I>
+    void ProcessLocal(const Cell& cell, uint8_t& center) {
+        using TState = std::variant_alternative_t<I, Variant>;
+        LocalNeighborhood<TState> neighborhood(cell, *this, denseTile, center);
+        TState state{};
+        state.Process(neighborhood);
+    }
+
+    void ApplyTransition(const Cell& cell, size_t fromTag, size_t toTag) {
+        if (summary) {
+            summary->Update(cell.x, cell.y, fromTag, toTag);
+        }
+        if (statistics) {
+            statistics->populations[fromTag]--;
+            statistics->populations[toTag]++;
+            statistics->transitions[fromTag * StateCount + toTag]++;
+        }
+        for (const auto& callback : transitionCallbacks[fromTag * StateCount + toTag]) {
+            callback(cell);
+        }
+    }
+
+    template<size_t... Is>
+    void ProcessCell(const Cell& cell, std::index_sequence<Is...>) {
+        const size_t tag = states[GetIndex(cell)].index();
+        ((tag == Is ? (ProcessState<Is>(cell), true) : false) || ...);
+    }
+
+    template<size_t I>
+    void ProcessState(const Cell& cell) {
+        using TState = std::variant_alternative_t<I, Variant>;
+        processedCounts[I]++;
+        StateNeighborhood<TState> neighborhood(cell, *this);
+        std::get<I>(states[GetIndex(cell)]).Process(neighborhood);
+    }
+
+    template<State<Neighborhood> TState>
+    void SetUnchecked(const Cell& cell) {
+        updatedStates[GetIndex(cell)] = TState{};
+        Enqueue(cell);
+    }
+
+    void Enqueue(const Cell& cell) {
+        auto& buffer = GetActiveBuffer();
+        for (int x = -neighborhoodSize; x <= neighborhoodSize; x++) {
+            for (int y = -neighborhoodSize; y <= neighborhoodSize; y++) {
+                Cell newCell = {static_cast<ShortInt>(cell.x + x), static_cast<ShortInt>(cell.y + y)};
+                if (!IsValid(newCell)) {
+                    continue;
+                }
+                if (!changedCells[GetIndex(newCell)]) {
+                    buffer.push_back(newCell);
+                    changedCells[GetIndex(newCell)] = true;
+                }
+            }
+        }
+    }
+
+    void EnqueueAll() {
+        auto& buffer = GetActiveBuffer();
+        for (ShortInt y = 0; y < Height; y++) {
+            for (ShortInt x = 0; x < Width; x++) {
+                const size_t index = GetIndex({x, y});
+                if (!changedCells[index]) {
+                    buffer.push_back({x, y});
+                    changedCells[index] = true;
+                }
+            }
+        }
+    }
+
+    template<size_t... Is>
+    void SetTag(const Cell& cell, size_t tag, std::index_sequence<Is...>) {
+        ((tag == Is ? (Set<std::variant_alternative_t<Is, Variant>>(cell), true) : false) || ...);
+    }
+
     [[nodiscard]] size_t GetIndex(const Cell& cell) const {
         return cell.x + cell.y * Width;
     }
@@ -296,10 +957,25 @@ private:
     std::vector<std::variant<TStates ...>> updatedStates;
     std::vector<std::variant<TStates ...>> states;
 
-    const size_t neighborhoodSize = 1;
+    const int neighborhoodSize = 1;
     Buffer modifiedCells;
     Buffer previouslyModifiedCells;
     std::vector<bool> changedCells;
+    std::array<size_t, sizeof...(TStates)> processedCounts = {};
+    static constexpr size_t denseTileSize = 64;
+    static constexpr size_t maxTemporalDepth = 4;
+    double denseThreshold = 0.5;
+    DenseTile denseTile;
+    Buffer denseChanges;
+    std::optional<SummaryPyramid> summary;
+
+    struct Statistics {
+        std::array<size_t, sizeof...(TStates)> populations = {};
+        std::array<size_t, sizeof...(TStates) * sizeof...(TStates)> transitions = {};
+    };
+    std::optional<Statistics> statistics;
+    std::array<std::vector<TransitionCallback>, sizeof...(TStates) * sizeof...(TStates)> transitionCallbacks;
+    size_t transitionCallbackCount = 0;
 
     bool firstBufferActive = true;
 };
@@ -0,0 +1,381 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+#include "CellularAutomata.h"
+
+/**
+ * File layout of a recorded history, all integers are LEB128 varints:
+ *   header: "CAHR" version width height keyframeInterval
+ *   frame:  type(1 byte) payloadSize payload
+ * A keyframe payload is a run-length encoding of the full grid as
+ * (runLength, tag) pairs, a delta payload is the number of changes
+ * followed by (index - previousIndex, tag) pairs in increasing index order.
+ * Generation g is stored as a keyframe when g is a multiple of the
+ * keyframe interval and as a delta otherwise.
+ */
+namespace History {
+    constexpr char Magic[4] = {'C', 'A', 'H', 'R'};
+    constexpr uint64_t Version = 1;
+
+    enum class FrameType : uint8_t {
+        Keyframe = 0,
+        Delta = 1
+    };
+
+    using Tag = uint8_t;
+    using Bytes = std::vector<uint8_t>;
+
+    inline void WriteVarint(Bytes& bytes, uint64_t value) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    inline uint64_t ReadVarint(const uint8_t*& it, const uint8_t* end) {
+        uint64_t value = 0;
+        for (int shift = 0; it != end && shift < 64; shift += 7) {
+            const uint8_t byte = *it++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("History: truncated varint");
+    }
+
+    inline uint64_t ReadVarint(std::istream& stream) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const int byte = stream.get();
+            if (byte == std::char_traits<char>::eof()) {
+                throw std::runtime_error("History: truncated varint");
+            }
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+        throw std::runtime_error("History: malformed varint");
+    }
+}
+
+/**
+ * @brief Streams the history of an automata to a file, one frame per
+ * generation. Only the cells committed by the last step are inspected,
+ * so recording costs O(changes) except for the periodic keyframes.
+ */
+class HistoryRecorder {
+public:
+    /**
+     * @brief Opens the file and records the current state of the automata
+     * as generation 0
+     * @param path The file to write to
+     * @param automata The automata to record
+     * @param keyframeInterval Number of generations between keyframes
+     */
+    template<typename TAutomata>
+    HistoryRecorder(const std::filesystem::path& path, const TAutomata& automata, size_t keyframeInterval = 256)
+        : stream(path, std::ios::binary | std::ios::trunc),
+          Width(automata.GetWidth()),
+          Height(automata.GetHeight()),
+          keyframeInterval(std::max<size_t>(keyframeInterval, 1)) {
+        static_assert(TAutomata::StateCount <= 256, "History stores tags in a single byte");
+        if (!stream) {
+            throw std::runtime_error("History: could not open " + path.string());
+        }
+        stream.write(History::Magic, sizeof(History::Magic));
+        History::Bytes header;
+        History::WriteVarint(header, History::Version);
+        History::WriteVarint(header, Width);
+        History::WriteVarint(header, Height);
+        History::WriteVarint(header, this->keyframeInterval);
+        stream.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+
+        tags.resize(static_cast<size_t>(Width) * Height);
+        WriteKeyframe(automata);
+    }
+
+    /**
+     * @brief Records the generation produced by the last Step of the automata,
+     * should be called once after every Step. Advance may commit several
+     * generations at once, a Record after it stores them as a single
+     * generation, so step with Step while recording.
+     * @param automata The automata to record
+     */
+    template<typename TAutomata>
+    void Record(const TAutomata& automata) {
+        generation++;
+        if (generation % keyframeInterval == 0) {
+            WriteKeyframe(automata);
+            return;
+        }
+
+        changes.clear();
+        for (const auto& cell : automata.GetCommittedCells()) {
+            const size_t index = cell.x + static_cast<size_t>(cell.y) * Width;
+            const auto tag = static_cast<History::Tag>(automata.GetTag(cell));
+            if (tags[index] != tag) {
+                tags[index] = tag;
+                changes.emplace_back(cell, tag);
+            }
+        }
+
+        // Two stable counting sort passes, on x and then on y, put the changes
+        // in index order in O(changes), a comparison sort dominates the cost
+        // of recording busy generations.
+        sortedChanges.resize(changes.size());
+        CountingSort(changes, sortedChanges, Width, [](const Cell& cell) { return cell.x; });
+        CountingSort(sortedChanges, changes, Height, [](const Cell& cell) { return cell.y; });
+
+        payload.clear();
+        History::WriteVarint(payload, changes.size());
+        size_t previous = 0;
+        for (const auto& [cell, tag] : changes) {
+            const size_t index = cell.x + static_cast<size_t>(cell.y) * Width;
+            History::WriteVarint(payload, index - previous);
+            History::WriteVarint(payload, tag);
+            previous = index;
+        }
+        WriteFrame(History::FrameType::Delta);
+    }
+
+    /**
+     * @brief Returns the generation that was recorded last
+     */
+    [[nodiscard]] size_t GetGeneration() const {
+        return generation;
+    }
+
+    /**
+     * @brief Flushes the recorded frames to the file
+     */
+    void Flush() {
+        stream.flush();
+    }
+
+private:
+    using Changes = std::vector<std::pair<Cell, History::Tag>>;
+
+    template<typename TAutomata>
+    void WriteKeyframe(const TAutomata& automata) {
+        payload.clear();
+        size_t run = 0;
+        History::Tag runTag = 0;
+        for (ShortInt y = 0; y < Height; y++) {
+            for (ShortInt x = 0; x < Width; x++) {
+                const auto tag = static_cast<History::Tag>(automata.GetTag({x, y}));
+                tags[x + static_cast<size_t>(y) * Width] = tag;
+                if (run > 0 && tag != runTag) {
+                    History::WriteVarint(payload, run);
+                    History::WriteVarint(payload, runTag);
+                    run = 0;
+                }
+                runTag = tag;
+                run++;
+            }
+        }
+        if (run > 0) {
+            History::WriteVarint(payload, run);
+            History::WriteVarint(payload, runTag);
+        }
+        WriteFrame(History::FrameType::Keyframe);
+    }
+
+    void CountingSort(const Changes& from, Changes& to, size_t keyCount, auto key) {
+        offsets.assign(keyCount + 1, 0);
+        for (const auto& change : from) {
+            offsets[key(change.first) + 1]++;
+        }
+        for (size_t i = 0; i < keyCount; i++) {
+            offsets[i + 1] += offsets[i];
+        }
+        for (const auto& change : from) {
+            to[offsets[key(change.first)]++] = change;
+        }
+    }
+
+    void WriteFrame(History::FrameType type) {
+        History::Bytes frameHeader;
+        frameHeader.push_back(static_cast<uint8_t>(type));
+        History::WriteVarint(frameHeader, payload.size());
+        stream.write(reinterpret_cast<const char*>(frameHeader.data()), static_cast<std::streamsize>(frameHeader.size()));
+        stream.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    }
+
+    std::ofstream stream;
+    const ShortInt Width = 0;
+    const ShortInt Height = 0;
+    const size_t keyframeInterval = 1;
+    size_t generation = 0;
+    std::vector<History::Tag> tags;
+    Changes changes;
+    Changes sortedChanges;
+    std::vector<size_t> offsets;
+    History::Bytes payload;
+};
+
+/**
+ * @brief Replays a history written by HistoryRecorder. Seeking decodes
+ * the closest keyframe at or before the target and applies the deltas
+ * after it, so a seek costs at most one keyframe interval of frames.
+ */
+class HistoryPlayer {
+public:
+    explicit HistoryPlayer(const std::filesystem::path& path) : stream(path, std::ios::binary) {
+        if (!stream) {
+            throw std::runtime_error("History: could not open " + path.string());
+        }
+        char magic[sizeof(History::Magic)] = {};
+        stream.read(magic, sizeof(magic));
+        if (!stream || !std::equal(std::begin(magic), std::end(magic), std::begin(History::Magic))) {
+            throw std::runtime_error("History: " + path.string() + " is not a history file");
+        }
+        if (History::ReadVarint(stream) != History::Version) {
+            throw std::runtime_error("History: unsupported version in " + path.string());
+        }
+        Width = static_cast<ShortInt>(History::ReadVarint(stream));
+        Height = static_cast<ShortInt>(History::ReadVarint(stream));
+        keyframeInterval = History::ReadVarint(stream);
+        if (keyframeInterval == 0) {
+            throw std::runtime_error("History: " + path.string() + " has a keyframe interval of 0");
+        }
+
+        // Index the frames up front, a truncated trailing frame, as left by a
+        // recorder that did not finish, is ignored.
+        const auto fileSize = static_cast<std::streamoff>(std::filesystem::file_size(path));
+        while (stream.peek() != std::char_traits<char>::eof()) {
+            const auto offset = stream.tellg();
+            stream.get();
+            std::streamoff size = 0;
+            try {
+                size = static_cast<std::streamoff>(History::ReadVarint(stream));
+            }
+            catch (const std::runtime_error&) {
+                if (!stream.eof()) {
+                    throw;
+                }
+                break;
+            }
+            if (stream.tellg() + size > fileSize) {
+                break;
+            }
+            stream.seekg(size, std::ios::cur);
+            frames.push_back(offset);
+        }
+        stream.clear();
+
+        tags.resize(static_cast<size_t>(Width) * Height);
+        if (frames.empty()) {
+            throw std::runtime_error("History: " + path.string() + " contains no frames");
+        }
+        ApplyFrame(0);
+    }
+
+    /**
+     * @brief Returns the number of generations in the history
+     */
+    [[nodiscard]] size_t GetGenerationCount() const {
+        return frames.size();
+    }
+
+    /**
+     * @brief Returns the generation the player is currently at
+     */
+    [[nodiscard]] size_t GetGeneration() const {
+        return generation;
+    }
+
+    /**
+     * @brief Moves the player to the generation, clamped to the last
+     * recorded generation
+     * @param target The generation to move to
+     */
+    void Seek(size_t target) {
+        target = std::min(target, frames.size() - 1);
+        const size_t keyframe = target / keyframeInterval * keyframeInterval;
+        if (target < generation || generation < keyframe) {
+            ApplyFrame(keyframe);
+        }
+        while (generation < target) {
+            ApplyFrame(generation + 1);
+        }
+    }
+
+    /**
+     * @brief Returns the tag of the cell at the current generation
+     * @param cell The cell to check
+     * @return The tag of the state of the cell
+     */
+    [[nodiscard]] size_t GetTag(const Cell& cell) const {
+        return tags.at(cell.x + static_cast<size_t>(cell.y) * Width);
+    }
+
+    /**
+     * @brief Loads the current generation into the automata as a committed
+     * step, see CellularAutomata::Load. Its next step processes every cell,
+     * so stepping continues the recorded run for local rules.
+     * @param automata The automata to write to, must have the recorded size
+     */
+    template<typename TAutomata>
+    void ApplyTo(TAutomata& automata) const {
+        if (automata.GetWidth() != Width || automata.GetHeight() != Height) {
+            throw std::runtime_error("History: the automata is not the size of the recording");
+        }
+        automata.Load(tags);
+    }
+
+    [[nodiscard]] ShortInt GetWidth() const {
+        return Width;
+    }
+
+    [[nodiscard]] ShortInt GetHeight() const {
+        return Height;
+    }
+
+private:
+    void ApplyFrame(size_t frame) {
+        stream.seekg(frames.at(frame));
+        const auto type = static_cast<History::FrameType>(stream.get());
+        payload.resize(History::ReadVarint(stream));
+        stream.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+
+        const uint8_t* it = payload.data();
+        const uint8_t* end = it + payload.size();
+        if (type == History::FrameType::Keyframe) {
+            size_t index = 0;
+            while (it != end) {
+                const size_t run = History::ReadVarint(it, end);
+                const auto tag = static_cast<History::Tag>(History::ReadVarint(it, end));
+                if (index + run > tags.size()) {
+                    throw std::runtime_error("History: keyframe overflows the grid");
+                }
+                std::fill_n(tags.begin() + static_cast<std::ptrdiff_t>(index), run, tag);
+                index += run;
+            }
+        }
+        else {
+            const size_t count = History::ReadVarint(it, end);
+            size_t index = 0;
+            for (size_t i = 0; i < count; i++) {
+                index += History::ReadVarint(it, end);
+                tags.at(index) = static_cast<History::Tag>(History::ReadVarint(it, end));
+            }
+        }
+        generation = frame;
+    }
+
+    std::ifstream stream;
+    ShortInt Width = 0;
+    ShortInt Height = 0;
+    size_t keyframeInterval = 1;
+    size_t generation = 0;
+    std::vector<std::streampos> frames;
+    std::vector<History::Tag> tags;
+    History::Bytes payload;
+};
@@ -0,0 +1,170 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Per-block state histograms of an automata at several resolutions.
+ * Level 0 summarises blocks of 4x4 cells and every following level blocks
+ * four times wider and higher, up to a single block covering the grid.
+ * The histograms are updated per changed cell, so keeping them costs
+ * O(changes * levels) and reading a level costs O(blocks in the level).
+ */
+class SummaryPyramid {
+public:
+    SummaryPyramid(size_t width, size_t height, size_t stateCount) : stateCount(stateCount) {
+        size_t blockSize = baseBlockSize;
+        while (true) {
+            Level level;
+            level.blockShift = Log2(blockSize);
+            level.width = (width + blockSize - 1) / blockSize;
+            level.height = (height + blockSize - 1) / blockSize;
+            level.counts.resize(level.width * level.height * stateCount);
+            levels.push_back(std::move(level));
+            if (blockSize >= width && blockSize >= height) {
+                break;
+            }
+            blockSize *= levelFactor;
+        }
+    }
+
+    /**
+     * @brief Counts a cell into the histograms, used to build the pyramid
+     * @param x The x coordinate of the cell
+     * @param y The y coordinate of the cell
+     * @param tag The tag of the state of the cell
+     */
+    void Add(size_t x, size_t y, size_t tag) {
+        for (auto& level : levels) {
+            level.counts[level.GetOffset(x, y, stateCount) + tag]++;
+        }
+    }
+
+    /**
+     * @brief Moves a cell from one state to another in the histograms
+     * @param x The x coordinate of the cell
+     * @param y The y coordinate of the cell
+     * @param fromTag The tag of the previous state of the cell
+     * @param toTag The tag of the new state of the cell
+     */
+    void Update(size_t x, size_t y, size_t fromTag, size_t toTag) {
+        for (auto& level : levels) {
+            const size_t offset = level.GetOffset(x, y, stateCount);
+            level.counts[offset + fromTag]--;
+            level.counts[offset + toTag]++;
+        }
+    }
+
+    /**
+     * @brief Returns the number of levels in the pyramid
+     */
+    [[nodiscard]] size_t GetLevelCount() const {
+        return levels.size();
+    }
+
+    /**
+     * @brief Returns the side in cells of the blocks of a level
+     * @param level The level to check
+     */
+    [[nodiscard]] size_t GetBlockSize(size_t level) const {
+        return size_t{1} << levels.at(level).blockShift;
+    }
+
+    /**
+     * @brief Returns the number of blocks along x of a level
+     * @param level The level to check
+     */
+    [[nodiscard]] size_t GetWidth(size_t level) const {
+        return levels.at(level).width;
+    }
+
+    /**
+     * @brief Returns the number of blocks along y of a level
+     * @param level The level to check
+     */
+    [[nodiscard]] size_t GetHeight(size_t level) const {
+        return levels.at(level).height;
+    }
+
+    /**
+     * @brief Returns the finest level that fits within the given number of blocks
+     * @param maxWidth The maximum number of blocks along x
+     * @param maxHeight The maximum number of blocks along y
+     * @return The level, or the coarsest level if none fits
+     */
+    [[nodiscard]] size_t GetLevelFor(size_t maxWidth, size_t maxHeight) const {
+        for (size_t level = 0; level < levels.size(); level++) {
+            if (levels[level].width <= maxWidth && levels[level].height <= maxHeight) {
+                return level;
+            }
+        }
+        return levels.size() - 1;
+    }
+
+    /**
+     * @brief Returns how many cells of a block are in a state
+     * @param level The level of the block
+     * @param blockX The x coordinate of the block in the level
+     * @param blockY The y coordinate of the block in the level
+     * @param tag The tag of the state
+     * @return The number of cells in the state
+     */
+    [[nodiscard]] size_t GetCount(size_t level, size_t blockX, size_t blockY, size_t tag) const {
+        const auto& summary = levels.at(level);
+        return summary.counts.at((blockX + blockY * summary.width) * stateCount + tag);
+    }
+
+    /**
+     * @brief Returns the most common state of a block, ties go to the lowest tag
+     * @param level The level of the block
+     * @param blockX The x coordinate of the block in the level
+     * @param blockY The y coordinate of the block in the level
+     * @return The tag of the most common state
+     */
+    [[nodiscard]] size_t GetDominant(size_t level, size_t blockX, size_t blockY) const {
+        const auto& summary = levels.at(level);
+        const auto begin = summary.counts.begin() + static_cast<std::ptrdiff_t>((blockX + blockY * summary.width) * stateCount);
+        return static_cast<size_t>(std::max_element(begin, begin + static_cast<std::ptrdiff_t>(stateCount)) - begin);
+    }
+
+    /**
+     * @brief Writes the most common state of every block of a level, row by row
+     * @param level The level to read
+     * @param tags The output, resized to GetWidth(level) * GetHeight(level)
+     */
+    void GetDominant(size_t level, std::vector<size_t>& tags) const {
+        const auto& summary = levels.at(level);
+        tags.resize(summary.width * summary.height);
+        for (size_t block = 0; block < tags.size(); block++) {
+            const auto begin = summary.counts.begin() + static_cast<std::ptrdiff_t>(block * stateCount);
+            tags[block] = static_cast<size_t>(std::max_element(begin, begin + static_cast<std::ptrdiff_t>(stateCount)) - begin);
+        }
+    }
+
+private:
+    struct Level {
+        size_t blockShift = 0;
+        size_t width = 0;
+        size_t height = 0;
+        std::vector<uint32_t> counts;
+
+        [[nodiscard]] size_t GetOffset(size_t x, size_t y, size_t stateCount) const {
+            return ((x >> blockShift) + (y >> blockShift) * width) * stateCount;
+        }
+    };
+
+    static constexpr size_t Log2(size_t value) {
+        size_t shift = 0;
+        while ((size_t{1} << shift) < value) {
+            shift++;
+        }
+        return shift;
+    }
+
+    static constexpr size_t baseBlockSize = 4;
+    static constexpr size_t levelFactor = 4;
+    const size_t stateCount = 0;
+    std::vector<Level> levels;
+};
@@ -0,0 +1,713 @@
+#include <cellaut-cpp/AutomataBatch.h>
+#include <cellaut-cpp/CellularAutomata.h>
+#include <cellaut-cpp/History.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Random outer totalistic rules over three states: the next state of a cell
+ * is looked up from its own state, the number of neighbors in state 1 and the
+ * number of neighbors in state 2 modulo 3. State 0 surrounded by state 0 stays
+ * state 0, so cells outside of the frontier are stable and Step has to match
+ * StepReference cell for cell.
+ */
+using RuleTable = std::array<std::array<std::array<uint8_t, 3>, 9>, 3>;
+inline RuleTable ruleTable = {};
+
+template<size_t Tag>
+struct RuleState;
+
+using RuleAutomata = CellularAutomata<RuleState<0>, RuleState<1>, RuleState<2>>;
+
+template<size_t Tag>
+struct RuleState {
+    static constexpr bool IsLocal = true;
+
+    void Process(auto& neighborhood) {
+        const auto& center = neighborhood.GetCenter();
+        size_t ones = 0;
+        size_t twos = 0;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                const Cell cell = {static_cast<ShortInt>(center.x + dx), static_cast<ShortInt>(center.y + dy)};
+                if ((dx == 0 && dy == 0) || !neighborhood.IsValid(cell)) {
+                    continue;
+                }
+                ones += neighborhood.template IsAt<RuleState<1>>(cell);
+                twos += neighborhood.template IsAt<RuleState<2>>(cell);
+            }
+        }
+        const size_t next = ruleTable[Tag][ones][twos % 3];
+        if (next == Tag) {
+            return;
+        }
+        if (next == 0) {
+            neighborhood.template Set<RuleState<0>>();
+        }
+        else if (next == 1) {
+            neighborhood.template Set<RuleState<1>>();
+        }
+        else {
+            neighborhood.template Set<RuleState<2>>();
+        }
+    }
+};
+
+struct Empty {
+    void Process(auto&) {}
+};
+
+struct Solid {
+    void Process(auto&) {}
+};
+
+using InertAutomata = CellularAutomata<Empty, Solid>;
+
+void RandomRule(std::mt19937& random) {
+    for (auto& byOnes : ruleTable) {
+        for (auto& byTwos : byOnes) {
+            for (auto& next : byTwos) {
+                next = static_cast<uint8_t>(random() % 3);
+            }
+        }
+    }
+    ruleTable[0][0][0] = 0;
+}
+
+/**
+ * Picks a random state for three quarters of the cells, the rest are left
+ * unset and keep state 0 until a neighbor changes.
+ */
+std::vector<size_t> RandomWorld(std::mt19937& random, ShortInt width, ShortInt height) {
+    std::vector<size_t> tags(static_cast<size_t>(width) * height, RuleAutomata::StateCount);
+    for (auto& tag : tags) {
+        if (random() % 4 != 0) {
+            tag = random() % RuleAutomata::StateCount;
+        }
+    }
+    return tags;
+}
+
+/**
+ * Sets the picked cells and steps once to commit them.
+ */
+void Fill(RuleAutomata& automata, const std::vector<size_t>& tags) {
+    for (ShortInt y = 0; y < automata.GetHeight(); y++) {
+        for (ShortInt x = 0; x < automata.GetWidth(); x++) {
+            const size_t tag = tags[x + static_cast<size_t>(y) * automata.GetWidth()];
+            if (tag < RuleAutomata::StateCount) {
+                automata.SetTag({x, y}, tag);
+            }
+        }
+    }
+    automata.Step();
+}
+
+bool HasUniqueCommittedCells(const auto& automata) {
+    auto cells = automata.GetCommittedCells();
+    std::sort(cells.begin(), cells.end());
+    return cells.size() <= automata.Size() && std::adjacent_find(cells.begin(), cells.end()) == cells.end();
+}
+
+constexpr size_t worldCount = 40;
+constexpr size_t generationCount = 12;
+
+bool StepMatchesReference() {
+    for (size_t seed = 0; seed < worldCount; seed++) {
+        std::mt19937 random(seed);
+        RandomRule(random);
+        const auto width = static_cast<ShortInt>(1 + random() % 150);
+        const auto height = static_cast<ShortInt>(1 + random() % 150);
+        const auto tags = RandomWorld(random, width, height);
+        RuleAutomata automata(width, height);
+        RuleAutomata reference(width, height);
+        Fill(automata, tags);
+        Fill(reference, tags);
+        for (size_t generation = 0; generation < generationCount; generation++) {
+            automata.Step();
+            reference.StepReference();
+            if (!automata.HasSameStates(reference) || !HasUniqueCommittedCells(automata)) {
+                std::cout << "Step diverged, seed " << seed << " generation " << generation << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool AdvanceMatchesReference() {
+    for (size_t seed = 0; seed < worldCount; seed++) {
+        std::mt19937 random(seed);
+        RandomRule(random);
+        const auto width = static_cast<ShortInt>(1 + random() % 150);
+        const auto height = static_cast<ShortInt>(1 + random() % 150);
+        const auto tags = RandomWorld(random, width, height);
+        RuleAutomata automata(width, height);
+        RuleAutomata reference(width, height);
+        Fill(automata, tags);
+        Fill(reference, tags);
+        // Alternate between always, sometimes and never stepping densely.
+        automata.SetDenseThreshold(std::array{0.0, 0.5, 2.0}[seed % 3]);
+        for (const size_t generations : {1, 5, 3, 8}) {
+            // Cells set between calls have to land after the first generation.
+            for (size_t i = 0; i < 30; i++) {
+                const Cell cell = {static_cast<ShortInt>(random() % width), static_cast<ShortInt>(random() % height)};
+                const size_t tag = random() % RuleAutomata::StateCount;
+                automata.SetTag(cell, tag);
+                reference.SetTag(cell, tag);
+            }
+            automata.Advance(generations);
+            for (size_t generation = 0; generation < generations; generation++) {
+                reference.StepReference();
+            }
+            if (!automata.HasSameStates(reference)) {
+                std::cout << "Advance diverged, seed " << seed << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool BatchMatchesReference() {
+    std::mt19937 random(7);
+    RandomRule(random);
+    constexpr ShortInt side = 48;
+    AutomataBatch<RuleState<0>, RuleState<1>, RuleState<2>> batch(worldCount, side, side, 4);
+    std::vector<RuleAutomata> references;
+    references.reserve(worldCount);
+    for (auto& world : batch) {
+        const auto tags = RandomWorld(random, side, side);
+        references.emplace_back(side, side);
+        Fill(world, tags);
+        Fill(references.back(), tags);
+    }
+    batch.Step();
+    batch.Step(generationCount - 1);
+    for (size_t i = 0; i < batch.Size(); i++) {
+        for (size_t generation = 0; generation < generationCount; generation++) {
+            references[i].StepReference();
+        }
+        if (!batch[i].HasSameStates(references[i])) {
+            std::cout << "AutomataBatch diverged, world " << i << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Set used to loop over the neighbors with an int compared against a size_t,
+ * which never ran, so the neighbors of a changed cell were never processed.
+ */
+bool SetQueuesNeighbors() {
+    InertAutomata automata(5, 5);
+    automata.Step();
+    automata.Set<Solid>({2, 2});
+    automata.Step();
+    if (automata.GetCommittedCells().size() != 9) {
+        std::cout << "Setting a center cell committed " << automata.GetCommittedCells().size() << " cells instead of 9\n";
+        return false;
+    }
+    automata.Set<Solid>({0, 0});
+    automata.Step();
+    if (automata.GetCommittedCells().size() != 4) {
+        std::cout << "Setting a corner cell committed " << automata.GetCommittedCells().size() << " cells instead of 4\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Set used to push the cell itself unconditionally, so a cell set many times
+ * in one step was committed once per set and the frontier grew without bound.
+ */
+bool SetDoesNotDuplicate() {
+    InertAutomata automata(5, 5);
+    automata.Step();
+    for (size_t i = 0; i < 100; i++) {
+        automata.Set<Solid>({2, 2});
+        automata.Set<Empty>({2, 2});
+    }
+    automata.Step();
+    if (automata.GetCommittedCells().size() != 9 || !HasUniqueCommittedCells(automata)) {
+        std::cout << "Setting a cell 200 times committed " << automata.GetCommittedCells().size() << " cells instead of 9\n";
+        return false;
+    }
+
+    std::mt19937 random(3);
+    RandomRule(random);
+    RuleAutomata busy(64, 64);
+    Fill(busy, RandomWorld(random, 64, 64));
+    for (size_t generation = 0; generation < 50; generation++) {
+        busy.Step();
+        if (!HasUniqueCommittedCells(busy)) {
+            std::cout << "The frontier holds duplicates at generation " << generation << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<size_t> GetTags(const RuleAutomata& automata) {
+    std::vector<size_t> tags;
+    tags.reserve(automata.Size());
+    for (ShortInt y = 0; y < automata.GetHeight(); y++) {
+        for (ShortInt x = 0; x < automata.GetWidth(); x++) {
+            tags.push_back(automata.GetTag({x, y}));
+        }
+    }
+    return tags;
+}
+
+/**
+ * Records generations steps of the automata, returns the tags of every
+ * recorded generation.
+ */
+std::vector<std::vector<size_t>> RecordRun(const std::filesystem::path& path, RuleAutomata& automata,
+                                           size_t generations, size_t keyframeInterval) {
+    std::vector<std::vector<size_t>> snapshots = {GetTags(automata)};
+    HistoryRecorder recorder(path, automata, keyframeInterval);
+    for (size_t generation = 0; generation < generations; generation++) {
+        automata.Step();
+        recorder.Record(automata);
+        snapshots.push_back(GetTags(automata));
+    }
+    return snapshots;
+}
+
+/**
+ * Every recorded generation has to decode to the automata as it was, in
+ * whatever order the player seeks, across keyframes and past the end.
+ */
+bool HistoryRoundTrips() {
+    std::mt19937 random(17);
+    RandomRule(random);
+    const auto path = std::filesystem::temp_directory_path() / "cellaut-cpp-tests-seek.cahr";
+    RuleAutomata automata(96, 64);
+    Fill(automata, RandomWorld(random, 96, 64));
+    const size_t generations = 40;
+    const auto snapshots = RecordRun(path, automata, generations, 8);
+
+    HistoryPlayer player(path);
+    std::filesystem::remove(path);
+    if (player.GetGenerationCount() != generations + 1 || player.GetWidth() != 96 || player.GetHeight() != 64) {
+        std::cout << "The history has the wrong size or number of generations\n";
+        return false;
+    }
+    for (const size_t target : {0, 3, 8, 9, 17, 40, 39, 16, 15, 7, 24, 23, 0, 100}) {
+        player.Seek(target);
+        const size_t generation = std::min(target, generations);
+        if (player.GetGeneration() != generation) {
+            std::cout << "Seeking to " << target << " ended at generation " << player.GetGeneration() << "\n";
+            return false;
+        }
+        for (ShortInt y = 0; y < player.GetHeight(); y++) {
+            for (ShortInt x = 0; x < player.GetWidth(); x++) {
+                if (player.GetTag({x, y}) != snapshots[generation][x + static_cast<size_t>(y) * player.GetWidth()]) {
+                    std::cout << "Generation " << generation << " decoded wrong at cell " << x << ", " << y << "\n";
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * ApplyTo has to leave the automata at the replayed generation right away,
+ * and stepping on from there has to continue the recorded run, also when
+ * the automata already holds that generation.
+ */
+bool HistoryApplyIsCommitted() {
+    std::mt19937 random(11);
+    RandomRule(random);
+    const auto path = std::filesystem::temp_directory_path() / "cellaut-cpp-tests-apply.cahr";
+    const auto tags = RandomWorld(random, 96, 64);
+    RuleAutomata automata(96, 64);
+    RuleAutomata twin(96, 64);
+    Fill(automata, tags);
+    Fill(twin, tags);
+    const auto snapshots = RecordRun(path, automata, generationCount, 4);
+    for (size_t generation = 0; generation < generationCount; generation++) {
+        twin.Step();
+    }
+
+    HistoryPlayer player(path);
+    std::filesystem::remove(path);
+    RuleAutomata replayed(96, 64);
+    replayed.EnableStatistics();
+    replayed.Set<RuleState<2>>({3, 3});
+    player.Seek(5);
+    player.ApplyTo(replayed);
+    if (GetTags(replayed) != snapshots[5]) {
+        std::cout << "ApplyTo left the automata at another generation\n";
+        return false;
+    }
+    if (replayed.GetPopulation<RuleState<0>>() != static_cast<size_t>(std::count(snapshots[5].begin(), snapshots[5].end(), 0))) {
+        std::cout << "ApplyTo did not update the statistics\n";
+        return false;
+    }
+    for (size_t generation = 6; generation <= generationCount; generation++) {
+        replayed.Step();
+        if (GetTags(replayed) != snapshots[generation]) {
+            std::cout << "Stepping after ApplyTo diverged from the recording at generation " << generation << "\n";
+            return false;
+        }
+    }
+
+    player.Seek(generationCount);
+    player.ApplyTo(automata);
+    for (size_t generation = 0; generation < 4; generation++) {
+        automata.Step();
+        twin.Step();
+        if (!automata.HasSameStates(twin)) {
+            std::cout << "Applying the generation the automata holds changed how it steps\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * A recorder that did not finish leaves a file that ends inside a frame,
+ * the player has to open it without that frame. A keyframe interval of 0
+ * would make seeking divide by zero and has to be rejected.
+ */
+bool HistoryRejectsBrokenFiles() {
+    std::mt19937 random(13);
+    RandomRule(random);
+    const auto path = std::filesystem::temp_directory_path() / "cellaut-cpp-tests-truncated.cahr";
+    RuleAutomata automata(96, 64);
+    Fill(automata, RandomWorld(random, 96, 64));
+    std::uintmax_t lastFrame = 0;
+    {
+        HistoryRecorder recorder(path, automata, 256);
+        for (size_t generation = 0; generation < 3; generation++) {
+            automata.Step();
+            recorder.Record(automata);
+        }
+        recorder.Flush();
+        lastFrame = std::filesystem::file_size(path);
+        automata.Step();
+        recorder.Record(automata);
+    }
+    // Cut inside the payload, inside the payload size and after the frame type.
+    for (const std::uintmax_t cut : {8, 2, 1}) {
+        std::filesystem::resize_file(path, lastFrame + cut);
+        try {
+            HistoryPlayer player(path);
+            if (player.GetGenerationCount() != 4) {
+                std::cout << "A history cut " << cut << " bytes into its last frame has "
+                          << player.GetGenerationCount() << " generations instead of 4\n";
+                return false;
+            }
+        }
+        catch (const std::runtime_error& error) {
+            std::cout << "A history cut " << cut << " bytes into its last frame did not open: " << error.what() << "\n";
+            return false;
+        }
+    }
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        const char header[] = {'C', 'A', 'H', 'R', 1, 1, 1, 0, 0, 2, 1, 0};
+        file.write(header, sizeof(header));
+    }
+    bool rejected = false;
+    try {
+        HistoryPlayer player(path);
+    }
+    catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    std::filesystem::remove(path);
+    if (!rejected) {
+        std::cout << "A history with a keyframe interval of 0 was opened\n";
+        return false;
+    }
+    return true;
+}
+
+using StateCounts = std::array<size_t, RuleAutomata::StateCount>;
+using TransitionCounts = std::array<size_t, RuleAutomata::StateCount * RuleAutomata::StateCount>;
+
+template<size_t... Is>
+StateCounts GetPopulations(const RuleAutomata& automata, std::index_sequence<Is...>) {
+    return {automata.GetPopulation<RuleState<Is>>()...};
+}
+
+template<size_t... Is>
+TransitionCounts GetTransitionCounts(const RuleAutomata& automata, std::index_sequence<Is...>) {
+    return {automata.GetTransitionCount<RuleState<Is / RuleAutomata::StateCount>, RuleState<Is % RuleAutomata::StateCount>>()...};
+}
+
+template<size_t... Is>
+void CountTransitions(RuleAutomata& automata, TransitionCounts& counts, std::index_sequence<Is...>) {
+    (automata.OnTransition<RuleState<Is / RuleAutomata::StateCount>, RuleState<Is % RuleAutomata::StateCount>>(
+        [&counts](const Cell&) { counts[Is]++; }), ...);
+}
+
+/**
+ * Populations, transition counts and callbacks have to match what a full
+ * scan of the grid sees, after Step and after Advance. While observed,
+ * Advance commits every generation on its own, so the callbacks have to
+ * see the transitions of every generation, also those that reverse later.
+ */
+bool StatisticsMatchScan() {
+    constexpr auto stateTags = std::make_index_sequence<RuleAutomata::StateCount>{};
+    constexpr auto transitionTags = std::make_index_sequence<RuleAutomata::StateCount * RuleAutomata::StateCount>{};
+    for (size_t seed = 0; seed < worldCount / 2; seed++) {
+        std::mt19937 random(seed);
+        RandomRule(random);
+        const auto width = static_cast<ShortInt>(1 + random() % 100);
+        const auto height = static_cast<ShortInt>(1 + random() % 100);
+        const auto tags = RandomWorld(random, width, height);
+        RuleAutomata automata(width, height);
+        RuleAutomata reference(width, height);
+        Fill(automata, tags);
+        Fill(reference, tags);
+        automata.SetDenseThreshold(seed % 2 == 0 ? 0.0 : 2.0);
+        automata.EnableStatistics();
+        TransitionCounts callbacks = {};
+        CountTransitions(automata, callbacks, transitionTags);
+
+        // 0 stands for a Step, anything else for an Advance of that many generations.
+        for (const size_t generations : {0, 1, 4, 0, 3, 2}) {
+            TransitionCounts expectedCallbacks = {};
+            TransitionCounts lastTransitions = {};
+            auto previous = GetTags(reference);
+            for (size_t generation = 0; generation < std::max<size_t>(generations, 1); generation++) {
+                reference.StepReference();
+                const auto current = GetTags(reference);
+                lastTransitions = {};
+                for (size_t i = 0; i < current.size(); i++) {
+                    if (previous[i] != current[i]) {
+                        lastTransitions[previous[i] * RuleAutomata::StateCount + current[i]]++;
+                        expectedCallbacks[previous[i] * RuleAutomata::StateCount + current[i]]++;
+                    }
+                }
+                previous = current;
+            }
+            callbacks = {};
+            if (generations == 0) {
+                automata.Step();
+            }
+            else {
+                automata.Advance(generations);
+            }
+
+            StateCounts populations = {};
+            for (const size_t tag : previous) {
+                populations[tag]++;
+            }
+            if (!automata.HasSameStates(reference)) {
+                std::cout << "Stepping with statistics diverged, seed " << seed << "\n";
+                return false;
+            }
+            if (GetPopulations(automata, stateTags) != populations) {
+                std::cout << "Populations differ from a scan, seed " << seed << "\n";
+                return false;
+            }
+            if (GetTransitionCounts(automata, transitionTags) != lastTransitions) {
+                std::cout << "Transition counts differ from the last generation, seed " << seed << "\n";
+                return false;
+            }
+            if (callbacks != expectedCallbacks) {
+                std::cout << "Callbacks missed transitions, seed " << seed << " generations " << generations << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool SummaryMatchesGrid(const RuleAutomata& automata) {
+    const auto& summary = automata.GetSummary();
+    for (size_t level = 0; level < summary.GetLevelCount(); level++) {
+        const size_t blockSize = summary.GetBlockSize(level);
+        for (size_t blockY = 0; blockY < summary.GetHeight(level); blockY++) {
+            for (size_t blockX = 0; blockX < summary.GetWidth(level); blockX++) {
+                StateCounts counts = {};
+                for (size_t y = blockY * blockSize; y < std::min<size_t>((blockY + 1) * blockSize, automata.GetHeight()); y++) {
+                    for (size_t x = blockX * blockSize; x < std::min<size_t>((blockX + 1) * blockSize, automata.GetWidth()); x++) {
+                        counts[automata.GetTag({static_cast<ShortInt>(x), static_cast<ShortInt>(y)})]++;
+                    }
+                }
+                for (size_t tag = 0; tag < RuleAutomata::StateCount; tag++) {
+                    if (summary.GetCount(level, blockX, blockY, tag) != counts[tag]) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return summary.GetWidth(summary.GetLevelCount() - 1) == 1 && summary.GetHeight(summary.GetLevelCount() - 1) == 1;
+}
+
+/**
+ * Every level of the summary pyramid has to count what a scan of each
+ * block counts, after Step, dense Advance, Load and after enabling it
+ * again, also on grids that are not a multiple of the block size.
+ */
+bool SummaryMatchesScan() {
+    const std::array<std::pair<ShortInt, ShortInt>, 5> sizes = {{{1, 1}, {5, 7}, {64, 64}, {67, 130}, {150, 3}}};
+    for (size_t seed = 0; seed < sizes.size(); seed++) {
+        std::mt19937 random(seed);
+        RandomRule(random);
+        const auto [width, height] = sizes[seed];
+        RuleAutomata automata(width, height);
+        Fill(automata, RandomWorld(random, width, height));
+        automata.EnableSummary();
+        const std::array<std::pair<const char*, std::function<void()>>, 4> steps = {{
+            {"Step", [&] { automata.Step(); }},
+            {"a dense Advance", [&] {
+                automata.SetDenseThreshold(0.0);
+                automata.Advance(4);
+            }},
+            {"Load", [&] {
+                std::vector<size_t> tags(automata.Size());
+                for (auto& tag : tags) {
+                    tag = random() % RuleAutomata::StateCount;
+                }
+                automata.Load(tags);
+            }},
+            {"enabling it again", [&] {
+                automata.DisableSummary();
+                automata.Step();
+                automata.EnableSummary();
+            }},
+        }};
+        if (!SummaryMatchesGrid(automata)) {
+            std::cout << "The summary of a " << width << "x" << height << " grid differs from a scan once enabled\n";
+            return false;
+        }
+        for (const auto& [name, step] : steps) {
+            step();
+            if (!SummaryMatchesGrid(automata)) {
+                std::cout << "The summary of a " << width << "x" << height << " grid differs from a scan after " << name << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+double TimeGenerations(size_t generations, auto&& step) {
+    const auto start = std::chrono::steady_clock::now();
+    step();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / generations;
+}
+
+/**
+ * A partly active grid: a patch in the middle alternates between states 1
+ * and 2 every generation and state 0 never changes, so the frontier is the
+ * patch and its border on every step.
+ */
+RuleAutomata PatchWorld(ShortInt side, ShortInt patchSide) {
+    for (size_t ones = 0; ones < 9; ones++) {
+        for (size_t twos = 0; twos < 3; twos++) {
+            ruleTable[0][ones][twos] = 0;
+            ruleTable[1][ones][twos] = 2;
+            ruleTable[2][ones][twos] = 1;
+        }
+    }
+    std::vector<size_t> tags(static_cast<size_t>(side) * side, RuleAutomata::StateCount);
+    const size_t first = (side - patchSide) / 2;
+    for (size_t y = first; y < first + patchSide; y++) {
+        for (size_t x = first; x < first + patchSide; x++) {
+            tags[x + y * side] = 1 + (x + y) % 2;
+        }
+    }
+    RuleAutomata automata(side, side);
+    Fill(automata, tags);
+    return automata;
+}
+
+/**
+ * Step has to process the frontier of a partly active grid at no more than
+ * three times the cost per cell of the reference, which processes every cell
+ * without any bookkeeping, and Advance must not lose to Step on a fully
+ * active grid. Step measures 1.5 to 2.3 times the reference from -O0 to -O3.
+ */
+bool Throughput() {
+    constexpr ShortInt side = 512;
+    constexpr ShortInt patchSide = 64;
+    RuleAutomata patch = PatchWorld(side, patchSide);
+    RuleAutomata patchReference = PatchWorld(side, patchSide);
+    const double referenceTime = TimeGenerations(generationCount, [&] {
+        for (size_t generation = 0; generation < generationCount; generation++) {
+            patchReference.StepReference();
+        }
+    });
+    // Step is cheap enough here to time ten times as many generations.
+    const double sparseTime = TimeGenerations(generationCount * 10, [&] {
+        for (size_t generation = 0; generation < generationCount * 10; generation++) {
+            patch.Step();
+        }
+    });
+    const size_t frontierSize = patch.GetCommittedCells().size();
+    const double referenceCellTime = referenceTime / patch.Size();
+    const double sparseCellTime = sparseTime / static_cast<double>(frontierSize);
+
+    std::mt19937 random(5);
+    RandomRule(random);
+    // Every state 0 cell without neighbors flips, so the whole grid stays active.
+    ruleTable[0][0][0] = 1;
+    const auto activeTags = RandomWorld(random, side, side);
+    RuleAutomata active(side, side);
+    RuleAutomata advanced(side, side);
+    Fill(active, activeTags);
+    Fill(advanced, activeTags);
+    const double stepTime = TimeGenerations(generationCount, [&] {
+        for (size_t generation = 0; generation < generationCount; generation++) {
+            active.Step();
+        }
+    });
+    const double advanceTime = TimeGenerations(generationCount, [&] {
+        advanced.Advance(generationCount);
+    });
+
+    std::cout << "Partly active grid, frontier of " << frontierSize << " cells\n";
+    std::cout << "  StepReference: " << referenceTime << " ms, " << referenceCellTime * 1e6 << " ns per cell\n";
+    std::cout << "  Step: " << sparseTime << " ms, " << sparseCellTime * 1e6 << " ns per frontier cell\n";
+    std::cout << "Fully active grid, Step: " << stepTime << " ms, Advance: " << advanceTime << " ms\n";
+    return frontierSize == static_cast<size_t>(patchSide + 2) * (patchSide + 2) &&
+        sparseCellTime < referenceCellTime * 3 && advanceTime < stepTime * 1.25;
+}
+
+int main(int argc, char** argv) {
+    const std::map<std::string, std::function<bool()>> tests = {
+        {"step", StepMatchesReference},
+        {"advance", AdvanceMatchesReference},
+        {"batch", BatchMatchesReference},
+        {"set-queues-neighbors", SetQueuesNeighbors},
+        {"set-does-not-duplicate", SetDoesNotDuplicate},
+        {"statistics", StatisticsMatchScan},
+        {"summary", SummaryMatchesScan},
+        {"history-seek", HistoryRoundTrips},
+        {"history-apply", HistoryApplyIsCommitted},
+        {"history-broken-files", HistoryRejectsBrokenFiles},
+        {"throughput", Throughput},
+    };
+    if (argc != 2 || !tests.contains(argv[1])) {
+        std::cout << "Usage: " << argv[0] << " <test>, one of:";
+        for (const auto& [name, test] : tests) {
+            std::cout << " " << name;
+        }
+        std::cout << "\n";
+        return 2;
+    }
+    return tests.at(argv[1])() ? 0 : 1;
+}